@@ -4,7 +4,10 @@
 #include <cstdio>
 #include <png.h>
 #include <cstdint>
+#include <array>
 #include <cstring>
+#include <stdexcept>
+#include <string>
 
 /// ГЕНЕРАЦИЯ КРУГА
 
@@ -203,24 +206,189 @@ std::vector<uint8_t> generate_uniform_alpha_mask(int w, int h) {
     return mask;
 }
 
+/// СТАТИСТИКА ИЗОБРАЖЕНИЯ
+
+// Гистограмма (256 бинов), min/max и сумма яркостей.
+// Заполняется попутно в циклах декодирования, смешивания и наложения маски,
+// чтобы QA не перечитывал готовые файлы.
+struct ImageStats {
+    uint64_t hist[256] = {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    int min = 255;
+    int max = 0;
+
+    double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+};
+
+// Локальная гистограмма одного прохода (своя у каждого потока/вызова).
+// Четыре чередующиеся подгистограммы (пиксель x идёт в x & 3): соседние
+// одинаковые пиксели увеличивают разные счётчики и не ждут друг друга,
+// что особенно важно на однотонных кадрах. Счётчики 64-битные, чтобы
+// не переполняться на изображениях больше 2^32 пикселей.
+// min/max/sum восстанавливаются из бинов при слиянии.
+struct LocalHistogram {
+    uint64_t bins[4][256] = {};
+
+    void add_row(const uint8_t* p, int n) {
+        int x = 0;
+        for (; x + 4 <= n; x += 4) {
+            ++bins[0][p[x]];
+            ++bins[1][p[x + 1]];
+            ++bins[2][p[x + 2]];
+            ++bins[3][p[x + 3]];
+        }
+        for (; x < n; ++x) ++bins[x & 3][p[x]];
+    }
+};
+
+// Сливает локальную гистограмму в общую статистику
+void merge_image_stats(ImageStats& stats, const LocalHistogram& local) {
+    for (int v = 0; v < 256; ++v) {
+        uint64_t c = local.bins[0][v] + local.bins[1][v] + local.bins[2][v] + local.bins[3][v];
+        if (!c) continue;
+        stats.hist[v] += c;
+        stats.count += c;
+        stats.sum += c * v;
+        if (v < stats.min) stats.min = v;
+        if (v > stats.max) stats.max = v;
+    }
+}
+
+// Кадр считается пересвеченным, если больше этой доли пикселей упёрлось в 255
+const double SATURATED_THRESHOLD = 0.01;
+
+// Сохраняет статистику в JSON рядом с изображением
+void write_stats_json(const char* path, const ImageStats& stats) {
+    FILE* fp = std::fopen(path, "wb");
+    if (!fp) throw std::runtime_error("fopen stats failed");
+
+    bool blank = stats.count == 0 || stats.min == stats.max;
+    // Учитываем только выбитые света: чёрный фон (0) пересветом не является
+    double saturated_fraction = stats.count ? static_cast<double>(stats.hist[255]) / stats.count : 0.0;
+    bool saturated = saturated_fraction > SATURATED_THRESHOLD;
+
+    std::fprintf(fp, "{\n");
+    std::fprintf(fp, "  \"count\": %llu,\n", static_cast<unsigned long long>(stats.count));
+    std::fprintf(fp, "  \"min\": %d,\n  \"max\": %d,\n", stats.count ? stats.min : 0, stats.max);
+    std::fprintf(fp, "  \"mean\": %.4f,\n", stats.mean());
+    std::fprintf(fp, "  \"blank\": %s,\n", blank ? "true" : "false");
+    std::fprintf(fp, "  \"saturated\": %s,\n", saturated ? "true" : "false");
+    std::fprintf(fp, "  \"saturated_fraction\": %.6f,\n", saturated_fraction);
+    std::fprintf(fp, "  \"histogram\": [");
+    for (int v = 0; v < 256; ++v) {
+        std::fprintf(fp, "%s%llu", v ? ", " : "", static_cast<unsigned long long>(stats.hist[v]));
+    }
+    std::fprintf(fp, "]\n}\n");
+
+    if (std::fclose(fp) != 0) throw std::runtime_error("write stats failed");
+}
+
+// Путь JSON-файла статистики для изображения: "out.png" -> "out.png.stats.json"
+std::string stats_sidecar_path(const char* image_path) {
+    return std::string(image_path) + ".stats.json";
+}
+
 /// Альфа-смешивание
 
+// Режим смешивания:
+// Srgb   - смешиваем закодированные sRGB значения напрямую (быстро, но темнит полутона)
+// Linear - смешиваем в линейном свете: sRGB -> линейное, lerp, линейное -> sRGB
+enum class BlendMode { Srgb, Linear };
+
+/// Таблицы перевода sRGB <-> линейный свет (считаются при компиляции)
+
+// t^0.4 = корень пятой степени из t^2, метод Ньютона (std::pow не constexpr)
+constexpr double pow_0_4(double t) {
+    double v = t * t;
+    double r = 1.0;  // Для v в (0, 1] сходимся сверху
+    for (int i = 0; i < 64; ++i) {
+        double r4 = r * r * r * r;
+        double next = (4.0 * r + v / r4) / 5.0;
+        if (next == r) break;
+        r = next;
+    }
+    return r;
+}
+
+// Декодирование sRGB: c в [0, 1] -> линейная яркость в [0, 1]
+constexpr double srgb_to_linear(double c) {
+    if (c <= 0.04045) return c / 12.92;
+    double t = (c + 0.055) / 1.055;
+    return t * t * pow_0_4(t);  // t^2.4
+}
+
+// 8 бит sRGB -> 16 бит линейного света
+constexpr std::array<uint16_t, 256> make_srgb8_to_linear16() {
+    std::array<uint16_t, 256> lut{};
+    for (int c = 0; c < 256; ++c) {
+        lut[c] = static_cast<uint16_t>(srgb_to_linear(c / 255.0) * 65535.0 + 0.5);
+    }
+    return lut;
+}
+
+// 16 бит линейного света -> 8 бит sRGB.
+// Порог между кодами c и c+1 - линейное значение середины (c + 0.5) / 255,
+// то есть округляем к ближайшему коду в sRGB, а не в линейном пространстве.
+constexpr std::array<uint8_t, 65536> make_linear16_to_srgb8() {
+    std::array<uint8_t, 65536> lut{};
+    int c = 0;
+    double threshold = srgb_to_linear(0.5 / 255.0) * 65535.0;
+    for (int v = 0; v < 65536; ++v) {
+        while (c < 255 && v > threshold) {
+            ++c;
+            threshold = c < 255 ? srgb_to_linear((c + 0.5) / 255.0) * 65535.0 : 65536.0;
+        }
+        lut[v] = static_cast<uint8_t>(c);
+    }
+    return lut;
+}
+
+constexpr std::array<uint16_t, 256> SRGB8_TO_LINEAR16 = make_srgb8_to_linear16();
+constexpr std::array<uint8_t, 65536> LINEAR16_TO_SRGB8 = make_linear16_to_srgb8();
+
+static_assert(SRGB8_TO_LINEAR16[0] == 0 && SRGB8_TO_LINEAR16[255] == 65535, "bad linearization table");
+static_assert(LINEAR16_TO_SRGB8[SRGB8_TO_LINEAR16[128]] == 128, "bad inverse table");
+
 // Смешивает два изображения A и B с весами из Alpha
 // Формула: out = ((255 - alpha) * A + alpha * B) / 255
 // При alpha=0: out=A (показываем только A)
 // При alpha=255: out=B (показываем только B)
 // При alpha=128: out=(A+B)/2 (50/50)
+// В режиме Linear та же формула применяется к 16-битным линейным значениям из таблиц
+// Если передан stats - попутно собирает статистику результата
 std::vector<uint8_t> blend_gray8(const std::vector<uint8_t>& A,
                                  const std::vector<uint8_t>& B,
                                  const std::vector<uint8_t>& Alpha,
-                                 int w, int h) {
+                                 int w, int h,
+                                 BlendMode mode = BlendMode::Srgb,
+                                 ImageStats* stats = nullptr) {
     std::vector<uint8_t> out(w * h);
-    for (int i = 0; i < w * h; ++i) {
-        int a = Alpha[i];
-        int a_inv = 255 - a;
-        // +127 для корректного округления при делении на 255
-        out[i] = static_cast<uint8_t>((a_inv * A[i] + a * B[i] + 127) / 255);
+    LocalHistogram local;
+    for (int y = 0; y < h; ++y) {
+        size_t row = static_cast<size_t>(y) * w;
+        if (mode == BlendMode::Linear) {
+            for (int x = 0; x < w; ++x) {
+                size_t i = row + x;
+                int a = Alpha[i];
+                int a_inv = 255 - a;
+                // Максимум 255 * 65535 - помещается в int
+                int lin = (a_inv * SRGB8_TO_LINEAR16[A[i]] + a * SRGB8_TO_LINEAR16[B[i]] + 127) / 255;
+                out[i] = LINEAR16_TO_SRGB8[lin];
+            }
+        } else {
+            for (int x = 0; x < w; ++x) {
+                size_t i = row + x;
+                int a = Alpha[i];
+                int a_inv = 255 - a;
+                // +127 для корректного округления при делении на 255
+                out[i] = static_cast<uint8_t>((a_inv * A[i] + a * B[i] + 127) / 255);
+            }
+        }
+        // Строка ещё в кэше - считаем гистограмму сразу, без повторного прохода
+        if (stats) local.add_row(&out[row], w);
     }
+    if (stats) merge_image_stats(*stats, local);
     return out;
 }
 
@@ -254,7 +422,9 @@ static void read_cb(png_structp png_ptr, png_bytep data, png_size_t len) {
     if (n != len) png_error(png_ptr, "short read");
 }
 
-void read_png_gray8(const char* path, std::vector<unsigned char>& img, int& w, int& h) {
+// Если передан stats - попутно собирает статистику декодированного изображения
+void read_png_gray8(const char* path, std::vector<unsigned char>& img, int& w, int& h,
+                    ImageStats* stats = nullptr) {
     FILE* fp = std::fopen(path, "rb");
     if (!fp) throw std::runtime_error("fopen failed");
 
@@ -312,6 +482,7 @@ void read_png_gray8(const char* path, std::vector<unsigned char>& img, int& w, i
     png_size_t rowbytes = png_get_rowbytes(png, info);
     std::vector<unsigned char> scan(rowbytes);
     img.assign(static_cast<size_t>(w) * h, 0);
+    LocalHistogram local;
 
     // Читаем и конвертируем с учетом прозрачности
     for (int y = 0; y < h; ++y) {
@@ -357,11 +528,15 @@ void read_png_gray8(const char* path, std::vector<unsigned char>& img, int& w, i
         else {
             png_error(png, "unsupported channels count");
         }
+
+        if (stats) local.add_row(dst, w);
     }
 
     png_read_end(png, nullptr);
     png_destroy_read_struct(&png, &info, nullptr);
     std::fclose(fp);
+
+    if (stats) merge_image_stats(*stats, local);
 }
 
 /// Колбэки для работы с файлами через наш рантайм
@@ -423,7 +598,9 @@ void write_png_gray8(const char* path, const std::vector<unsigned char>& img, in
     std::fclose(fp);
 }
 
-void apply_circle_mask_to_image(const char* input_path, const char* output_path) {
+// Если передан stats - попутно собирает статистику результата
+void apply_circle_mask_to_image(const char* input_path, const char* output_path,
+                                ImageStats* stats = nullptr) {
     try {
         std::cout << "Applying circular mask to image: " << input_path << "\n";
 
@@ -458,9 +635,16 @@ void apply_circle_mask_to_image(const char* input_path, const char* output_path)
 
         // Применяем маску: умножаем изображение на маску
         std::vector<uint8_t> result(w * h, 0);
-        for (int i = 0; i < w * h; ++i) {
-            result[i] = static_cast<uint8_t>((img[i] * mask[i]) / 255);
+        LocalHistogram local;
+        for (int y = 0; y < h; ++y) {
+            size_t row = static_cast<size_t>(y) * w;
+            for (int x = 0; x < w; ++x) {
+                size_t i = row + x;
+                result[i] = static_cast<uint8_t>((img[i] * mask[i]) / 255);
+            }
+            if (stats) local.add_row(&result[row], w);
         }
+        if (stats) merge_image_stats(*stats, local);
 
         // Сохраняем результат
         write_png_gray8(output_path, result, w, h);
@@ -487,12 +671,16 @@ void task1_generating_halftone_circle() {
     std::cout << "\nChecking: reading circle.png back...\n";
     std::vector<uint8_t> test_img;
     int rw = 0, rh = 0;
-    read_png_gray8("circle.png", test_img, rw, rh);
+    // Статистику для QA собираем прямо при проверочном чтении, без отдельного прохода
+    ImageStats stats;
+    read_png_gray8("circle.png", test_img, rw, rh, &stats);
     std::cout << "Readed back: " << rw << "x" << rh << "\n";
+    write_stats_json(stats_sidecar_path("circle.png").c_str(), stats);
 
     std::cout << "\nTASK 1 DONE!\n";
     std::cout << "Created:\n";
-    std::cout << "  - circle.png (circular halftone image)\n\n";
+    std::cout << "  - circle.png (circular halftone image)\n";
+    std::cout << "  - circle.png.stats.json (image statistics)\n\n";
 }
 
 /// ЗАДАНИЕ 1: Маска в виде круга
@@ -510,13 +698,15 @@ void task1_circle_mask() {
     };
 
     for (int i = 0; i < 3; ++i) {
-        apply_circle_mask_to_image(images_paths_input[i], images_paths_output[i]);
+        ImageStats stats;
+        apply_circle_mask_to_image(images_paths_input[i], images_paths_output[i], &stats);
+        write_stats_json(stats_sidecar_path(images_paths_output[i]).c_str(), stats);
     }
 
 }
 
 /// ЗАДАНИЕ 2: Смешивание трёх пар изображений
-void task2_blending_synthetic_images() {
+void task2_blending_synthetic_images(BlendMode mode) {
     const int W = 512; // Ширина синтетических изображений
     const int H = 512; // Высота синтетических изображений
 
@@ -555,8 +745,10 @@ void task2_blending_synthetic_images() {
 
     // Смешивание
     std::cout << "Processing alpha blending...\n";
-    auto blended1 = blend_gray8(imgA1, imgB1, alpha, W, H);
+    ImageStats stats1;
+    auto blended1 = blend_gray8(imgA1, imgB1, alpha, W, H, mode, &stats1);
     write_png_gray8(paths_output[0], blended1, W, H);
+    write_stats_json(stats_sidecar_path(paths_output[0]).c_str(), stats1);
     std::cout << "Saved: " << paths_output[0] << "\n\n";
 
     /// ПАРА 2: Радиальный градиент + Круг
@@ -573,8 +765,10 @@ void task2_blending_synthetic_images() {
     std::cout << "Sizes are equal\n";
 
     std::cout << "Processing alpha blending...\n";
-    auto blended2 = blend_gray8(imgA2, imgB2, alpha, W, H);
+    ImageStats stats2;
+    auto blended2 = blend_gray8(imgA2, imgB2, alpha, W, H, mode, &stats2);
     write_png_gray8(paths_output[1], blended2, W, H);
+    write_stats_json(stats_sidecar_path(paths_output[1]).c_str(), stats2);
     std::cout << "Saved: " << paths_output[1] << "\n\n";
 
     /// ПАРА 3: Горизонтальный градиент + Диагональный градиент (обратная пара 1)
@@ -591,14 +785,16 @@ void task2_blending_synthetic_images() {
     std::cout << "Sizes are equal\n";
 
     std::cout << "Processing alpha blending...\n";
-    auto blended3 = blend_gray8(imgA3, imgB3, alpha, W, H);
+    ImageStats stats3;
+    auto blended3 = blend_gray8(imgA3, imgB3, alpha, W, H, mode, &stats3);
     write_png_gray8(paths_output[2], blended3, W, H);
+    write_stats_json(stats_sidecar_path(paths_output[2]).c_str(), stats3);
     std::cout << "Saved: " << paths_output[2] << "\n\n";
 }
 
 
 /// ЗАДАНИЕ 2: Смешивание несинтетических картинок
-void task2_blending_non_synthetic_images() {
+void task2_blending_non_synthetic_images(BlendMode mode) {
 
     const char* images_for_blending_paths_input[] = {
             "image1_for_blending.png",
@@ -626,17 +822,22 @@ void task2_blending_non_synthetic_images() {
 
     std::vector<uint8_t> alpha2 = generate_uniform_alpha_mask(w1, h1);
 
-    auto blended_image1 = blend_gray8(image1_for_blending, image2_for_blending, alpha2, w1, h1);
-    auto blended_image2 = blend_gray8(image2_for_blending, image3_for_blending, alpha2, w1, h1);
-    auto blended_image3 = blend_gray8(image3_for_blending, image1_for_blending, alpha2, w1, h1);
+    ImageStats stats[3];
+    auto blended_image1 = blend_gray8(image1_for_blending, image2_for_blending, alpha2, w1, h1, mode, &stats[0]);
+    auto blended_image2 = blend_gray8(image2_for_blending, image3_for_blending, alpha2, w1, h1, mode, &stats[1]);
+    auto blended_image3 = blend_gray8(image3_for_blending, image1_for_blending, alpha2, w1, h1, mode, &stats[2]);
 
     write_png_gray8(images_for_blending_paths_output[0], blended_image1, w1, h1);
     write_png_gray8(images_for_blending_paths_output[1], blended_image2, w2, h2);
     write_png_gray8(images_for_blending_paths_output[2], blended_image3, w3, h3);
+
+    for (int i = 0; i < 3; ++i) {
+        write_stats_json(stats_sidecar_path(images_for_blending_paths_output[i]).c_str(), stats[i]);
+    }
 }
 
 // ДОБАВЛЕНО
-void task2_blending_images_with_input_mask() {
+void task2_blending_images_with_input_mask(BlendMode mode) {
     const char* images_for_blending_paths_input[] = {
             "image1_for_blending.png",
             "image2_for_blending.png",
@@ -666,23 +867,42 @@ void task2_blending_images_with_input_mask() {
     // но так как мы каждый раз просто выбираем маску из трех поступивших изображений, то в нашем случае она будет излишней
     checkIfSizesEquals(w1, h1, w2, h2, w3, h3);
 
-    auto blended_image1 = blend_gray8(image1_for_blending, image2_for_blending, image3_for_blending, w1, h1);
-    auto blended_image2 = blend_gray8(image2_for_blending, image3_for_blending, image1_for_blending, w1, h1);
-    auto blended_image3 = blend_gray8(image3_for_blending, image1_for_blending, image2_for_blending, w1, h1);
+    ImageStats stats[3];
+    auto blended_image1 = blend_gray8(image1_for_blending, image2_for_blending, image3_for_blending, w1, h1, mode, &stats[0]);
+    auto blended_image2 = blend_gray8(image2_for_blending, image3_for_blending, image1_for_blending, w1, h1, mode, &stats[1]);
+    auto blended_image3 = blend_gray8(image3_for_blending, image1_for_blending, image2_for_blending, w1, h1, mode, &stats[2]);
 
     write_png_gray8(images_for_blending_paths_output[0], blended_image1, w1, h1);
     write_png_gray8(images_for_blending_paths_output[1], blended_image2, w2, h2);
     write_png_gray8(images_for_blending_paths_output[2], blended_image3, w3, h3);
+
+    for (int i = 0; i < 3; ++i) {
+        write_stats_json(stats_sidecar_path(images_for_blending_paths_output[i]).c_str(), stats[i]);
+    }
 }
 
-int main() {
+// Использование: my_program2 [--blend=srgb|linear]
+int main(int argc, char** argv) {
+    BlendMode mode = BlendMode::Srgb;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--blend=srgb") == 0) {
+            mode = BlendMode::Srgb;
+        } else if (std::strcmp(argv[i], "--blend=linear") == 0) {
+            mode = BlendMode::Linear;
+        } else {
+            std::cerr << "Error: unknown argument " << argv[i] << "\n";
+            std::cerr << "Usage: " << argv[0] << " [--blend=srgb|linear]\n";
+            return 1;
+        }
+    }
+
     try {
         task1_circle_mask();
         task1_generating_halftone_circle();
-        task2_blending_synthetic_images();
-        task2_blending_non_synthetic_images();
+        task2_blending_synthetic_images(mode);
+        task2_blending_non_synthetic_images(mode);
         // ДОБАВЛЕНО
-        task2_blending_images_with_input_mask();
+        task2_blending_images_with_input_mask(mode);
 
         return 0;
     } catch (const std::exception& e) {